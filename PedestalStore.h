@@ -0,0 +1,186 @@
+// ------------------------------------------------------------------------------------
+//  Binary pedestal store, one file per run : pedestals/ped_<run>.bin
+//  Pedestals estimated from the input go to pedestals/ped_<run>.estimate.bin instead.
+//
+//  The fixed-width text tables written by HCALPedestalTableMaker (pedestals/ped_<run>.txt)
+//  are converted once into a flat array of PedestalRecord behind a small header. Loading a
+//  run is then a single mmap of that file, with no parsing.
+//
+//  File layout (native byte order) :
+//      PedestalFileHeader
+//      PedestalRecord[nrecords]
+// ------------------------------------------------------------------------------------
+
+#ifndef PEDESTALSTORE_H
+#define PEDESTALSTORE_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "TSystem.h"
+#include "TString.h"
+
+using namespace std;
+
+const char pedestalMagic[8] = {'H', 'C', 'A', 'L', 'P', 'E', 'D', 'S'};
+//Version 2: ped_<run>.bin is only written from tables, never from pedestals estimated on the input
+const UInt_t pedestalVersion = 2;
+
+//Units of the pedestal values, as in the "#U" lines of the text tables
+enum { kPedADC = 0, kPedFC = 1 };
+
+struct PedestalFileHeader {
+    char magic[8];
+    UInt_t version;
+    UInt_t run;
+    UInt_t nrecords;
+    UInt_t reserved;
+};
+
+//One channel: mean and width of each of the 4 capacitors
+struct PedestalRecord {
+    Short_t ieta;
+    Short_t iphi;
+    Short_t depth;
+    char subdet; //HB=1, HE=2, HO=3, HF=4, CRF=8
+    char unit;   //kPedADC or kPedFC
+    UInt_t detid;
+    float mean[4];
+    float width[4];
+};
+
+inline TString pedestalCachePath(UInt_t run, TString dir = "pedestals") { return Form("%s/ped_%u.bin", dir.Data(), run); }
+inline TString pedestalTablePath(UInt_t run, TString dir = "pedestals") { return Form("%s/ped_%u.txt", dir.Data(), run); }
+inline TString pedestalEstimatePath(UInt_t run, TString dir = "pedestals") { return Form("%s/ped_%u.estimate.bin", dir.Data(), run); }
+
+inline int pedestalSubdetCode(TString det) {
+    if (det == "HB") return 1;
+    if (det == "HE") return 2;
+    if (det == "HO") return 3;
+    if (det == "HF") return 4;
+    if (det == "CRF") return 8;
+    return 0;
+}
+
+//Parse a text table from HCALPedestalTableMaker. Tables of several subdetectors may be
+//appended to the same file, each starting with its own "#U" unit line.
+inline bool readPedestalTable(TString path, vector<PedestalRecord> &records) {
+    ifstream fin(path.Data());
+    if (!fin.is_open()) return false;
+
+    int unit = kPedADC;
+    string line;
+    while (getline(fin, line)) {
+        if (line.empty()) continue;
+        if (line[0] == '#') {
+            if (line.compare(0, 2, "#U") == 0) unit = (line.find("fC") != string::npos) ? kPedFC : kPedADC;
+            continue;
+        }
+        istringstream ss(line);
+        int ieta, iphi, depth;
+        string det, detid;
+        PedestalRecord rec;
+        ss >> ieta >> iphi >> depth >> det;
+        for (int icap = 0; icap < 4; icap++) ss >> rec.mean[icap];
+        for (int icap = 0; icap < 4; icap++) ss >> rec.width[icap];
+        ss >> detid;
+        if (ss.fail()) {
+            cout << Form("Skipping malformed line in %s: %s", path.Data(), line.c_str()) << endl;
+            continue;
+        }
+        rec.ieta = ieta;
+        rec.iphi = iphi;
+        rec.depth = depth;
+        rec.subdet = pedestalSubdetCode(det.c_str());
+        rec.unit = unit;
+        rec.detid = strtoul(detid.c_str(), 0, 16);
+        records.push_back(rec);
+    }
+    return true;
+}
+
+//Write the cache for one run. The file is written under a temporary name and renamed,
+//so concurrent jobs never see a partial cache. An empty cache is never written.
+inline bool writePedestalCache(TString path, UInt_t run, const vector<PedestalRecord> &records) {
+    if (records.size() == 0) return false;
+    PedestalFileHeader header;
+    memcpy(header.magic, pedestalMagic, sizeof(pedestalMagic));
+    header.version = pedestalVersion;
+    header.run = run;
+    header.nrecords = records.size();
+    header.reserved = 0;
+
+    TString tmpPath = Form("%s.tmp%i", path.Data(), gSystem->GetPid());
+    ofstream fout(tmpPath.Data(), ios_base::binary | ios_base::out | ios_base::trunc);
+    if (!fout.is_open()) return false;
+    fout.write((const char*)&header, sizeof(header));
+    fout.write((const char*)&records[0], records.size() * sizeof(PedestalRecord));
+    fout.close();
+    if (fout.fail()) { gSystem->Unlink(tmpPath); return false; }
+    return gSystem->Rename(tmpPath, path) == 0;
+}
+
+//Read-only mapping of one run's cache file
+class PedestalCache {
+public:
+    PedestalCache() : map_(0), size_(0), header_(0), records_(0) {}
+    ~PedestalCache() { close(); }
+
+    //Map the file and check that it is a complete cache for this run
+    bool open(TString path, UInt_t run) {
+        close();
+        int fd = ::open(path.Data(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(PedestalFileHeader)) { ::close(fd); return false; }
+        void *map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) return false;
+        map_ = map;
+        size_ = st.st_size;
+
+        header_ = (const PedestalFileHeader*)map_;
+        if (memcmp(header_->magic, pedestalMagic, sizeof(pedestalMagic)) != 0 || header_->version != pedestalVersion ||
+            header_->run != run || size_ != sizeof(PedestalFileHeader) + (size_t)header_->nrecords * sizeof(PedestalRecord)) {
+            cout << Form("Ignoring invalid pedestal cache %s", path.Data()) << endl;
+            close();
+            return false;
+        }
+        records_ = (const PedestalRecord*)(header_ + 1);
+        return true;
+    }
+
+    void close() {
+        if (map_) munmap(map_, size_);
+        map_ = 0;
+        size_ = 0;
+        header_ = 0;
+        records_ = 0;
+    }
+
+    UInt_t size() const { return header_ ? header_->nrecords : 0; }
+    const PedestalRecord &operator[](UInt_t i) const { return records_[i]; }
+    //0 if the cache is closed or empty
+    const PedestalRecord *records() const { return size() > 0 ? records_ : 0; }
+
+private:
+    PedestalCache(const PedestalCache&);
+    PedestalCache &operator=(const PedestalCache&);
+
+    void *map_;
+    size_t size_;
+    const PedestalFileHeader *header_;
+    const PedestalRecord *records_;
+};
+
+#endif
@@ -0,0 +1,85 @@
+// ------------------------------------------------------------------------------------
+//  Stage timers for the benchmark harness (benchmarkTiming.C)
+//
+//  Wall and CPU time of named stages ("io", "eventLoop", "render", ...) and a few
+//  counters ("events", "plots") are accumulated per process. reportStages() appends
+//  them to the file named by $HCAL_BENCH_REPORT, one line per stage or counter:
+//
+//      stage <program> <pid> <name> <real s> <cpu s> <calls>
+//      count <program> <pid> <name> <value>
+//
+//  Without $HCAL_BENCH_REPORT nothing is written, and timing a stage costs two clock reads.
+// ------------------------------------------------------------------------------------
+
+#ifndef STAGETIMERS_H
+#define STAGETIMERS_H
+
+#include <cstdio>
+#include <map>
+#include <string>
+
+#include "TSystem.h"
+#include "TString.h"
+#include "TStopwatch.h"
+
+using namespace std;
+
+struct StageTime {
+    double real, cpu;
+    Long64_t calls;
+    StageTime() : real(0), cpu(0), calls(0) {}
+};
+
+inline map<string, StageTime> &stageTimes() { static map<string, StageTime> times; return times; }
+inline map<string, double> &stageCounts() { static map<string, double> counts; return counts; }
+
+//Add a duration measured elsewhere, e.g. summed over worker threads
+inline void addStageTime(const char *name, double real, double cpu) {
+    StageTime &t = stageTimes()[name];
+    t.real += real;
+    t.cpu += cpu;
+    t.calls++;
+}
+
+inline void addStageCount(const char *name, double value) { stageCounts()[name] += value; }
+
+//Times the enclosing scope as one call of a stage
+class ScopedStage {
+public:
+    ScopedStage(const char *name) : name_(name) { watch_.Start(); }
+    ~ScopedStage() {
+        watch_.Stop();
+        addStageTime(name_, watch_.RealTime(), watch_.CpuTime());
+    }
+private:
+    ScopedStage(const ScopedStage&);
+    ScopedStage &operator=(const ScopedStage&);
+
+    const char *name_;
+    TStopwatch watch_;
+};
+
+//Append the stages and counters of this process to $HCAL_BENCH_REPORT and reset them.
+//Everything goes out in one write, so concurrent worker processes do not interleave lines.
+inline void reportStages(const char *program) {
+    const char *path = gSystem->Getenv("HCAL_BENCH_REPORT");
+    if (path && (stageTimes().size() > 0 || stageCounts().size() > 0)) {
+        int pid = gSystem->GetPid();
+        TString lines;
+        for (map<string, StageTime>::iterator it = stageTimes().begin(); it != stageTimes().end(); ++it) {
+            lines += Form("stage %s %i %s %.6f %.6f %lld\n", program, pid, it->first.c_str(), it->second.real, it->second.cpu, it->second.calls);
+        }
+        for (map<string, double>::iterator it = stageCounts().begin(); it != stageCounts().end(); ++it) {
+            lines += Form("count %s %i %s %.0f\n", program, pid, it->first.c_str(), it->second);
+        }
+        FILE *fout = fopen(path, "a");
+        if (fout) {
+            fwrite(lines.Data(), 1, lines.Length(), fout);
+            fclose(fout);
+        }
+    }
+    stageTimes().clear();
+    stageCounts().clear();
+}
+
+#endif
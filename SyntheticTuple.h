@@ -0,0 +1,348 @@
+// ------------------------------------------------------------------------------------
+//  Synthetic hcalTupleTree ntuples, for benchmarks that need no CMS data
+//
+//  Writes every branch read by makeTimingHists, HCALPedestalTableMaker and monitorTiming,
+//  with the types they bind:
+//
+//      event, ls, run
+//      QIE11Digi{RawID,Subdet,IEta,IPhi,Depth,CapID,ADC,FC,FCPedSub,TimeTDC,NTDC,
+//                TimeFC,TimeFCPedSub,TotFC,TotFCPedSub}     HB + HE, 8 time samples, ADC as int
+//      HBHEDigi{RawID,Subdet,IEta,IPhi,Depth,CapID,ADC,NomFC} HB + HE, 8 time samples, pedestal only
+//      HODigi{RawID,Subdet,IEta,IPhi,Depth,CapID,ADC,NomFC}   HO, 8 time samples, pedestal only
+//      HFDigi{RawID,Subdet,IEta,IPhi,Depth,CapID,ADC,NomFC}   HF depths 1-2, 8 time samples, pedestal only
+//      QIE10Digi{RawID,Subdet,IEta,IPhi,Depth,CapID,ADC}      HF depths 1-4, 8 time samples, pedestal only,
+//                                                             CapID counted from 1
+//
+//  so HCALPedestalTableMaker runs on every subdetector of its default list.
+//  Every channel has fixed pedestals per capacitor and a fixed timing offset around 81 ns,
+//  drawn from the run number, so all files of one run describe the same detector.
+//  writeSyntheticPedestalCache() writes the true QIE11 pedestals of a run as a PedestalStore.h cache.
+//  Per event, each channel is read out with probability occupancy; a read-out QIE11 channel
+//  carries a pulse (5000 fC and up, TDC time = channel offset + jitter) with probability
+//  signalFraction, otherwise only pedestal.
+// ------------------------------------------------------------------------------------
+
+#ifndef SYNTHETICTUPLE_H
+#define SYNTHETICTUPLE_H
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TDirectory.h"
+#include "TMath.h"
+#include "TRandom3.h"
+#include "TString.h"
+
+#include "PedestalStore.h"
+
+using namespace std;
+
+//Bumped whenever the branches or their content change, so stale benchmark datasets are regenerated
+const int syntheticTupleVersion = 2;
+
+struct SyntheticTupleConfig {
+    int nEvents;
+    double occupancy;      //fraction of channels read out per event
+    double signalFraction; //fraction of read-out QIE11 channels with a pulse
+    UInt_t run;
+    UInt_t seed;           //event content; pedestals and timing offsets only depend on run
+    SyntheticTupleConfig() : nEvents(1000), occupancy(0.1), signalFraction(0.5), run(300000), seed(1) {}
+};
+
+//One channel of the synthetic detector
+struct SyntheticChannel {
+    int ieta, iphi, depth, subdet, rawid;
+    float pedMean[4], pedWidth[4];
+    float timeOffset; //ns
+};
+
+//HcalDetId-like raw ID: subdetector, depth, z side, |ieta| and iphi
+inline int syntheticRawID(int subdet, int ieta, int iphi, int depth) {
+    return (4 << 28) | (subdet << 25) | (depth << 20) | (ieta > 0 ? 0x80000 : 0) | (abs(ieta) << 10) | iphi;
+}
+
+//Digi collections of the synthetic detector
+enum { kSynthQIE11, kSynthHBHE, kSynthHO, kSynthHF, kSynthQIE10, nSynthTypes };
+
+//Channels of one digi collection: phase 1 QIE11 (HB up to depth 4, HE up to depth 7), the legacy
+//HBHE depths, HO (depth 4), HF (depths 1-2) or QIE10 HF (depths 1-4). HF has every other iphi, and
+//every fourth at |ieta| 40-41. QIE11 pedestals are in fC, all others in ADC counts.
+inline vector<SyntheticChannel> syntheticChannels(int type, UInt_t run) {
+    const double pedMean[nSynthTypes] = {25, 4, 8, 3, 6};
+    const double pedSpread[nSynthTypes] = {3, 0.5, 1, 0.4, 0.8};
+    const double widthMin[nSynthTypes] = {1.5, 0.4, 0.6, 0.4, 0.5};
+    const double widthMax[nSynthTypes] = {3, 0.8, 1.0, 0.7, 1.0};
+
+    TRandom3 rng(run * nSynthTypes + type + 1);
+    vector<SyntheticChannel> channels;
+    bool hf = (type == kSynthHF || type == kSynthQIE10);
+    int mineta = hf ? 29 : 1;
+    int maxeta = hf ? 41 : (type == kSynthHO ? 15 : 29);
+    for (int aeta = mineta; aeta <= maxeta; aeta++) {
+        int subdet, mindepth = 1, maxdepth, firstphi = 1, dphi = 1;
+        if (type == kSynthQIE11) {
+            subdet = (aeta < 16) ? 1 : 2;
+            if (aeta <= 15) maxdepth = 4;
+            else if (aeta == 16) maxdepth = 4;
+            else if (aeta == 17) maxdepth = 2;
+            else if (aeta <= 26) maxdepth = 7;
+            else maxdepth = 3;
+        }
+        else if (type == kSynthHBHE) {
+            subdet = (aeta < 16) ? 1 : 2;
+            maxdepth = (aeta <= 14) ? 2 : 3;
+        }
+        else if (type == kSynthHO) {
+            subdet = 3;
+            mindepth = maxdepth = 4;
+        }
+        else {
+            subdet = 4;
+            maxdepth = (type == kSynthQIE10) ? 4 : 2;
+            firstphi = (aeta >= 40) ? 3 : 1;
+            dphi = (aeta >= 40) ? 4 : 2;
+        }
+        for (int side = -1; side <= 1; side += 2) {
+            for (int iphi = firstphi; iphi <= 72; iphi += dphi) {
+                for (int depth = mindepth; depth <= maxdepth; depth++) {
+                    SyntheticChannel chan;
+                    chan.ieta = side * aeta;
+                    chan.iphi = iphi;
+                    chan.depth = depth;
+                    //ieta 16 is shared: the outermost depth belongs to HE
+                    chan.subdet = (aeta == 16 && !hf) ? (depth == maxdepth ? 2 : 1) : subdet;
+                    chan.rawid = syntheticRawID(chan.subdet, chan.ieta, iphi, depth);
+                    for (int icap = 0; icap < 4; icap++) {
+                        chan.pedMean[icap] = rng.Gaus(pedMean[type], pedSpread[type]);
+                        chan.pedWidth[icap] = rng.Uniform(widthMin[type], widthMax[type]);
+                    }
+                    chan.timeOffset = rng.Gaus(81, 3);
+                    channels.push_back(chan);
+                }
+            }
+        }
+    }
+    return channels;
+}
+
+//Fraction of a pulse starting at t0 collected in [t1, t2): gamma(2) shape with a 10 ns time constant
+inline double syntheticPulseFraction(double t0, double t1, double t2) {
+    const double tau = 10;
+    double x1 = TMath::Max(0., (t1 - t0) / tau), x2 = TMath::Max(0., (t2 - t0) / tau);
+    return (1 + x1) * TMath::Exp(-x1) - (1 + x2) * TMath::Exp(-x2);
+}
+
+//Monotonic, saturating stand-in for the QIE11 ADC
+inline int syntheticADC(double fC) { return (int)TMath::Min(255., TMath::Max(0., 25 * TMath::Log(1 + fC / 5.))); }
+
+//Charge-averaged time and total charge of the 4 TS around the peak, as findDigiTimefC and findTotalfC in makeTimingHists
+inline void syntheticChargeTime(const vector<float> &fC, float &time, float &total) {
+    int max_idx = distance(fC.begin(), max_element(fC.begin(), fC.end()));
+    int min = TMath::Max(max_idx - 1, 0);
+    int max = TMath::Min(max_idx + 2, (int)fC.size() - 1);
+    time = 0;
+    total = 0;
+    for (int i = min; i <= max; i++) {
+        time += (i + 1) * fC[i];
+        total += fC[i];
+    }
+    time = (time / total - 1.) * 25.;
+}
+
+//One pedestal-only digi collection with ADC as float: HBHEDigi, HODigi, HFDigi or QIE10Digi
+struct SyntheticADCDigis {
+    vector<int> rawid, subdet, ieta, iphi, depth;
+    vector<vector<int> > capid;
+    vector<vector<float> > adc, nomFC;
+    int capidBase; //value of the first capacitor, 1 for QIE10
+    bool withNomFC;
+
+    void branch(TTree *tree, TString prefix, int base, bool nomfc) {
+        capidBase = base;
+        withNomFC = nomfc;
+        tree->Branch(prefix + "RawID", &rawid);
+        tree->Branch(prefix + "Subdet", &subdet);
+        tree->Branch(prefix + "IEta", &ieta);
+        tree->Branch(prefix + "IPhi", &iphi);
+        tree->Branch(prefix + "Depth", &depth);
+        tree->Branch(prefix + "CapID", &capid);
+        tree->Branch(prefix + "ADC", &adc);
+        if (withNomFC) tree->Branch(prefix + "NomFC", &nomFC);
+    }
+
+    //Read out each channel with probability occupancy, pedestal only
+    void fill(const vector<SyntheticChannel> &channels, double occupancy, int nTS, TRandom3 &rng) {
+        rawid.clear(); subdet.clear(); ieta.clear(); iphi.clear(); depth.clear();
+        capid.clear(); adc.clear(); nomFC.clear();
+        vector<int> caps(nTS);
+        vector<float> counts(nTS), charge(nTS);
+        for (unsigned int ichan = 0; ichan < channels.size(); ichan++) {
+            if (rng.Rndm() >= occupancy) continue;
+            const SyntheticChannel &chan = channels[ichan];
+            int cap0 = rng.Integer(4);
+            for (int its = 0; its < nTS; its++) {
+                int icap = (cap0 + its) % 4;
+                caps[its] = capidBase + icap;
+                counts[its] = TMath::Max(0., (double)TMath::Nint(rng.Gaus(chan.pedMean[icap], chan.pedWidth[icap])));
+                charge[its] = 2.6 * counts[its];
+            }
+            rawid.push_back(chan.rawid);
+            subdet.push_back(chan.subdet);
+            ieta.push_back(chan.ieta);
+            iphi.push_back(chan.iphi);
+            depth.push_back(chan.depth);
+            capid.push_back(caps);
+            adc.push_back(counts);
+            if (withNomFC) nomFC.push_back(charge);
+        }
+    }
+};
+
+//Write one ntuple; returns the number of events written, 0 if the file could not be created
+inline int writeSyntheticTuple(TString path, const SyntheticTupleConfig &cfg) {
+    const int nTS = 8;
+
+    static vector<SyntheticChannel> channels[nSynthTypes];
+    static UInt_t channelsRun = 0;
+    if (channels[kSynthQIE11].size() == 0 || channelsRun != cfg.run) {
+        for (int type = 0; type < nSynthTypes; type++) channels[type] = syntheticChannels(type, cfg.run);
+        channelsRun = cfg.run;
+    }
+    const vector<SyntheticChannel> &qie11Channels = channels[kSynthQIE11];
+
+    TFile *file = new TFile(path, "RECREATE");
+    if (!file || file->IsZombie()) {
+        delete file;
+        return 0;
+    }
+    file->mkdir("hcalTupleTree")->cd();
+    TTree *tree = new TTree("tree", "tree");
+
+    UInt_t event = 0, ls = 0, run = cfg.run;
+    tree->Branch("event", &event, "event/i");
+    tree->Branch("ls", &ls, "ls/i");
+    tree->Branch("run", &run, "run/i");
+
+    vector<int> QIE11DigiRawID, QIE11DigiSubdet, QIE11DigiIEta, QIE11DigiIPhi, QIE11DigiDepth, QIE11DigiNTDC;
+    vector<vector<int> > QIE11DigiCapID, QIE11DigiADC;
+    vector<vector<float> > QIE11DigiFC, QIE11DigiFCPedSub;
+    vector<float> QIE11DigiTimeTDC, QIE11DigiTimeFC, QIE11DigiTimeFCPedSub, QIE11DigiTotFC, QIE11DigiTotFCPedSub;
+    tree->Branch("QIE11DigiRawID", &QIE11DigiRawID);
+    tree->Branch("QIE11DigiSubdet", &QIE11DigiSubdet);
+    tree->Branch("QIE11DigiIEta", &QIE11DigiIEta);
+    tree->Branch("QIE11DigiIPhi", &QIE11DigiIPhi);
+    tree->Branch("QIE11DigiDepth", &QIE11DigiDepth);
+    tree->Branch("QIE11DigiCapID", &QIE11DigiCapID);
+    tree->Branch("QIE11DigiADC", &QIE11DigiADC);
+    tree->Branch("QIE11DigiFC", &QIE11DigiFC);
+    tree->Branch("QIE11DigiFCPedSub", &QIE11DigiFCPedSub);
+    tree->Branch("QIE11DigiTimeTDC", &QIE11DigiTimeTDC);
+    tree->Branch("QIE11DigiNTDC", &QIE11DigiNTDC);
+    tree->Branch("QIE11DigiTimeFC", &QIE11DigiTimeFC);
+    tree->Branch("QIE11DigiTimeFCPedSub", &QIE11DigiTimeFCPedSub);
+    tree->Branch("QIE11DigiTotFC", &QIE11DigiTotFC);
+    tree->Branch("QIE11DigiTotFCPedSub", &QIE11DigiTotFCPedSub);
+
+    SyntheticADCDigis hbhe, ho, hf, qie10;
+    hbhe.branch(tree, "HBHEDigi", 0, true);
+    ho.branch(tree, "HODigi", 0, true);
+    hf.branch(tree, "HFDigi", 0, true);
+    qie10.branch(tree, "QIE10Digi", 1, false);
+
+    TRandom3 rng(cfg.seed);
+    vector<int> capid(nTS), adc(nTS);
+    vector<float> fC(nTS), fCPedSub(nTS);
+
+    for (int ievent = 0; ievent < cfg.nEvents; ievent++) {
+        event = cfg.seed * 1000000 + ievent;
+        ls = 1 + ievent / 1000;
+
+        QIE11DigiRawID.clear(); QIE11DigiSubdet.clear(); QIE11DigiIEta.clear(); QIE11DigiIPhi.clear(); QIE11DigiDepth.clear();
+        QIE11DigiNTDC.clear(); QIE11DigiCapID.clear(); QIE11DigiADC.clear(); QIE11DigiFC.clear(); QIE11DigiFCPedSub.clear();
+        QIE11DigiTimeTDC.clear(); QIE11DigiTimeFC.clear(); QIE11DigiTimeFCPedSub.clear(); QIE11DigiTotFC.clear(); QIE11DigiTotFCPedSub.clear();
+        for (unsigned int ichan = 0; ichan < qie11Channels.size(); ichan++) {
+            if (rng.Rndm() >= cfg.occupancy) continue;
+            const SyntheticChannel &chan = qie11Channels[ichan];
+
+            bool signal = rng.Rndm() < cfg.signalFraction;
+            double charge = signal ? 5000 + rng.Exp(5000) : 0;
+            double t0 = chan.timeOffset + rng.Gaus(0, 2) - 4; //pulse start; the charge-averaged time comes out near the offset
+
+            int cap0 = rng.Integer(4);
+            for (int its = 0; its < nTS; its++) {
+                capid[its] = (cap0 + its) % 4;
+                double ped = rng.Gaus(chan.pedMean[capid[its]], chan.pedWidth[capid[its]]);
+                double pulse = signal ? charge * syntheticPulseFraction(t0, 25 * its, 25 * (its + 1)) : 0;
+                fC[its] = ped + pulse;
+                fCPedSub[its] = fC[its] - chan.pedMean[capid[its]];
+                adc[its] = syntheticADC(fC[its]);
+            }
+            float timeFC, totFC, timeFCPedSub, totFCPedSub;
+            syntheticChargeTime(fC, timeFC, totFC);
+            syntheticChargeTime(fCPedSub, timeFCPedSub, totFCPedSub);
+
+            int nTDC = 0;
+            float timeTDC = -1;
+            if (signal) {
+                nTDC = (rng.Rndm() < 0.95) ? 1 : 2;
+                timeTDC = TMath::Nint(2 * (chan.timeOffset + rng.Gaus(0, 1.5))) / 2.; //0.5 ns TDC steps
+            }
+
+            QIE11DigiRawID.push_back(chan.rawid);
+            QIE11DigiSubdet.push_back(chan.subdet);
+            QIE11DigiIEta.push_back(chan.ieta);
+            QIE11DigiIPhi.push_back(chan.iphi);
+            QIE11DigiDepth.push_back(chan.depth);
+            QIE11DigiCapID.push_back(capid);
+            QIE11DigiADC.push_back(adc);
+            QIE11DigiFC.push_back(fC);
+            QIE11DigiFCPedSub.push_back(fCPedSub);
+            QIE11DigiTimeTDC.push_back(timeTDC);
+            QIE11DigiNTDC.push_back(nTDC);
+            QIE11DigiTimeFC.push_back(timeFC);
+            QIE11DigiTimeFCPedSub.push_back(timeFCPedSub);
+            QIE11DigiTotFC.push_back(totFC);
+            QIE11DigiTotFCPedSub.push_back(totFCPedSub);
+        }
+
+        hbhe.fill(channels[kSynthHBHE], cfg.occupancy, nTS, rng);
+        ho.fill(channels[kSynthHO], cfg.occupancy, nTS, rng);
+        hf.fill(channels[kSynthHF], cfg.occupancy, nTS, rng);
+        qie10.fill(channels[kSynthQIE10], cfg.occupancy, nTS, rng);
+
+        tree->Fill();
+    }
+
+    tree->Write();
+    file->Close();
+    delete file;
+    return cfg.nEvents;
+}
+
+//Write the true QIE11 fC pedestals of a run to pedestalCachePath(run, dir), as makeTimingHists
+//would load them from a converted table. Returns false if the cache could not be written.
+inline bool writeSyntheticPedestalCache(UInt_t run, TString dir = "pedestals") {
+    vector<SyntheticChannel> channels = syntheticChannels(kSynthQIE11, run);
+    vector<PedestalRecord> records;
+    for (unsigned int ichan = 0; ichan < channels.size(); ichan++) {
+        const SyntheticChannel &chan = channels[ichan];
+        PedestalRecord rec;
+        rec.ieta = chan.ieta;
+        rec.iphi = chan.iphi;
+        rec.depth = chan.depth;
+        rec.subdet = chan.subdet;
+        rec.unit = kPedFC;
+        rec.detid = chan.rawid;
+        for (int icap = 0; icap < 4; icap++) {
+            rec.mean[icap] = chan.pedMean[icap];
+            rec.width[icap] = chan.pedWidth[icap];
+        }
+        records.push_back(rec);
+    }
+    return writePedestalCache(pedestalCachePath(run, dir), run, records);
+}
+
+#endif